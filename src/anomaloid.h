@@ -1,24 +1,11 @@
 #pragma once
 
+#include "collision.h"
 #include "components.h"
+#include "transform.h"
+#include "utils/poisson_disk.h"
 #include "utils/util.h"
 
-void collisionDetection(flecs::world& ecs) {
-    DeferGuard g(ecs);
-    ecs.each([&ecs](flecs::entity e1, const BoundingBox& box1) {
-        ecs.each([&](flecs::entity e2, const BoundingBox& box2) {
-            // fmt::println("Checking {} and {}", e1, e2);
-            if (e1 == e2) {
-                return;
-            }
-            if (box1.intersects(box2)) {
-                fmt::println("Collision detected! {} {}", e1, e2);
-                e1.add<CollidedWith>(e2);
-            }
-        });
-    });
-}
-
 void deleteCollided(flecs::world& ecs) {
     DeferGuard g(ecs);
 
@@ -64,8 +51,7 @@ void deleteCollided(flecs::world& ecs) {
 flecs::entity spawnAnomaloid(flecs::world& ecs, Mass mass, Position pos) {
     Radius      radius(mass.v);
     BoundingBox boundingBox = {
-        .top = Vec2(pos.v.x - radius.v, pos.v.y - radius.v),
-        .bot = Vec2(pos.v.x + radius.v, pos.v.y + radius.v)
+        .top = Vec2(-radius.v, -radius.v), .bot = Vec2(radius.v, radius.v)
     };
 
     sf::CircleShape circle(radius.v, 100);
@@ -76,43 +62,76 @@ flecs::entity spawnAnomaloid(flecs::world& ecs, Mass mass, Position pos) {
     circle.setOutlineThickness(1);
 
     return ecs.entity()
-        .set(AnomalyMult(randomFloat(1., 10)))
+        .set(AnomalyMult(randomFloat(worldCtx(ecs).gen, 1., 10)))
         .set(mass)
         .set(pos)
         .set(radius)
         .set(boundingBox)
+        .add<WorldBox>()
+        .set(ANOMALOID_LAYER)
         .set(std::move(circle));
 }
 
-void spawnAnomaloids(flecs::world& ecs, int number) {
+enum class Placement {
+    Uniform,      // may overlap; the collision pass then removes some
+    PoissonDisk,  // exactly `number`, never overlapping
+};
+
+// Poisson-disk placement throws if the anomaloids don't fit
+void spawnAnomaloids(
+    flecs::world& ecs,
+    int           number,
+    Placement     placement = Placement::PoissonDisk
+) {
+    std::mt19937&                        gen = worldCtx(ecs).gen;
     std::exponential_distribution<float> d(1.5);
+
+    if (placement == Placement::Uniform) {
+        for (int i = 0; i < number; ++i) {
+            Mass     mass(d(gen) * 40);
+            Position pos(randomVec2(gen, -800, 800, -500, 500));
+            spawnAnomaloid(ecs, mass, pos);
+        }
+        propagateTransforms(ecs);
+        collisionDetection(ecs);
+        deleteCollided(ecs);
+        return;
+    }
+
+    // The radius is the mass, see spawnAnomaloid
+    std::vector<float> masses(number);
+    for (float& mass : masses) {
+        mass = d(gen) * 40;
+    }
+    std::vector<Vec2> centers = poissonDiskPlacement(
+        gen, masses, Vec2(-800, -500), Vec2(800, 500)
+    );
     for (int i = 0; i < number; ++i) {
-        Mass     mass(d(gen) * 40);
-        Position pos(randomVec2(-800, 800, -500, 500));
-        spawnAnomaloid(ecs, mass, pos);
+        spawnAnomaloid(ecs, Mass(masses[i]), Position(centers[i]));
     }
+    propagateTransforms(ecs);
+}
 
-    collisionDetection(ecs);
-    deleteCollided(ecs);
+// Applies an anomaloid's sf::Color to its circle when the color is set or
+// removed, so rendering never has to write the shape
+void registerAnomaloidColors(flecs::world& ecs) {
+    ecs.observer<const sf::Color, sf::CircleShape>()
+        .term_at(1)
+        .filter()
+        .with<AnomalyMult>()
+        .event(flecs::OnSet)
+        .event(flecs::OnRemove)
+        .each([](flecs::iter& it, size_t, const sf::Color& color,
+                 sf::CircleShape& circle) {
+            circle.setFillColor(
+                it.event() == flecs::OnRemove ? sf::Color::White : color
+            );
+        });
 }
 
 void renderAnomaloids(flecs::world& ecs, sf::RenderTarget& window) {
-    ecs.each([&](const flecs::entity e, const Position& pos,
-                 sf::CircleShape& circle, const AnomalyMult& _) {
-        if (auto color = e.get<sf::Color>()) {
-            circle.setFillColor(*color);
-        } else {
-            circle.setFillColor(sf::Color::White);
-        }
-        circle.setPosition(pos.v);
-
+    ecs.each([&](const sf::CircleShape& circle, const AnomalyMult&) {
         window.draw(circle);
-
-        textDrawer.draw({.pos = pos.v, .color = sf::Color::Black}, e);
-        textDrawer.draw(
-            {.pos = pos.v + Vec2(0, 20), .color = sf::Color::Black},
-            *e.get<Mass>()
-        );
     });
 }
 
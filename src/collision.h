@@ -0,0 +1,241 @@
+#pragma once
+
+#include <flecs.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "components.h"
+#include "utils/util.h"
+
+/**** Broad Phase ****/
+
+// One sweep-and-prune list per layer, sorted along x. Layer pairs that no
+// mask allows are never walked, so filtered pairs cost nothing.
+//
+// The lists persist across ticks: only entities whose world bounds changed are
+// updated. Re-sorting pulls the touched entries out of the still-sorted rest,
+// sorts just those and merges them back, so a tick costs O(N + k log k) for k
+// touched entries, and layers nobody touched cost nothing.
+struct BroadPhase {
+    struct Entry {
+        flecs::entity e;
+        BoundingBox   box;
+        uint32_t      mask;
+        bool          removed = false;
+        bool          touched = true;  // inserted or moved since last sort
+    };
+
+    struct Slot {
+        int      layer;
+        uint32_t index;
+    };
+
+    std::array<std::vector<Entry>, NUM_COLLISION_LAYERS> layers;
+    std::array<uint32_t, NUM_COLLISION_LAYERS>           layerMasks{};
+    std::array<bool, NUM_COLLISION_LAYERS>               dirty{};
+    std::unordered_map<uint64_t, Slot>                   slots;
+
+    void upsert(flecs::entity e, const BoundingBox& box, CollisionLayer l) {
+        int layer = std::countr_zero(l.category);
+        if (auto it = this->slots.find(e.id()); it != this->slots.end()) {
+            if (it->second.layer == layer) {
+                Entry& entry  = this->layers[layer][it->second.index];
+                entry.box     = box;
+                entry.mask    = l.mask;
+                entry.touched = true;
+                this->layerMasks[layer] |= l.mask;
+                this->dirty[layer] = true;
+                return;
+            }
+            this->remove(e);
+        }
+        this->slots[e.id()] = {layer, uint32_t(this->layers[layer].size())};
+        this->layers[layer].push_back({e, box, l.mask});
+        this->layerMasks[layer] |= l.mask;
+        this->dirty[layer] = true;
+    }
+
+    void remove(flecs::entity e) {
+        if (auto it = this->slots.find(e.id()); it != this->slots.end()) {
+            this->layers[it->second.layer][it->second.index].removed = true;
+            this->dirty[it->second.layer] = true;
+            this->slots.erase(it);
+        }
+    }
+
+    // Drops removed entries and restores x order
+    void sort() {
+        auto byX = [](const Entry& a, const Entry& b) {
+            return a.box.top.x < b.box.top.x;
+        };
+        for (int l = 0; l < NUM_COLLISION_LAYERS; ++l) {
+            if (!this->dirty[l]) {
+                continue;
+            }
+            auto& layer = this->layers[l];
+            std::erase_if(layer, [](const Entry& e) { return e.removed; });
+
+            // Untouched entries are still in x order
+            auto touched = std::stable_partition(
+                layer.begin(), layer.end(),
+                [](const Entry& e) { return !e.touched; }
+            );
+            std::sort(touched, layer.end(), byX);
+            std::inplace_merge(layer.begin(), touched, layer.end(), byX);
+
+            this->layerMasks[l] = 0;
+            for (size_t i = 0; i < layer.size(); ++i) {
+                layer[i].touched                   = false;
+                this->slots[layer[i].e.id()].index = i;
+                this->layerMasks[l] |= layer[i].mask;
+            }
+            this->dirty[l] = false;
+        }
+    }
+
+    bool layersInteract(int a, int b) const {
+        return (this->layerMasks[a] & (1u << b)) &&
+               (this->layerMasks[b] & (1u << a));
+    }
+
+    template <typename Func>
+    void pairs(Func&& onPair) const {
+        for (int a = 0; a < NUM_COLLISION_LAYERS; ++a) {
+            for (int b = a; b < NUM_COLLISION_LAYERS; ++b) {
+                if (!this->layersInteract(a, b)) {
+                    continue;
+                }
+                if (a == b) {
+                    sweep(this->layers[a], a, onPair);
+                } else {
+                    sweep(this->layers[a], a, this->layers[b], b, onPair);
+                }
+            }
+        }
+    }
+
+   private:
+    static bool accepts(const Entry& e, int otherLayer) {
+        return e.mask & (1u << otherLayer);
+    }
+
+    template <typename Func>
+    static void
+    sweep(const std::vector<Entry>& l, int layer, Func& onPair) {
+        for (size_t i = 0; i < l.size(); ++i) {
+            if (!accepts(l[i], layer)) {
+                continue;
+            }
+            for (size_t j = i + 1;
+                 j < l.size() && l[j].box.top.x < l[i].box.bot.x; ++j) {
+                if (accepts(l[j], layer) && l[i].box.intersects(l[j].box)) {
+                    onPair(l[i].e, l[j].e);
+                }
+            }
+        }
+    }
+
+    // Walks both lists in x order; each entry is tested against the entries of
+    // the other list that start before it ends and haven't been walked yet.
+    template <typename Func>
+    static void sweep(
+        const std::vector<Entry>& la,
+        int                       a,
+        const std::vector<Entry>& lb,
+        int                       b,
+        Func&                     onPair
+    ) {
+        size_t i = 0, j = 0;
+        while (i < la.size() && j < lb.size()) {
+            bool         takeA      = la[i].box.top.x <= lb[j].box.top.x;
+            const Entry& cur        = takeA ? la[i++] : lb[j++];
+            const auto&  other      = takeA ? lb : la;
+            int          curLayer   = takeA ? a : b;
+            int          otherLayer = takeA ? b : a;
+            if (!accepts(cur, otherLayer)) {
+                continue;
+            }
+            for (size_t k = takeA ? j : i;
+                 k < other.size() && other[k].box.top.x < cur.box.bot.x; ++k) {
+                if (accepts(other[k], curLayer) &&
+                    cur.box.intersects(other[k].box)) {
+                    onPair(cur.e, other[k].e);
+                }
+            }
+        }
+    }
+};
+
+/**** Spatial Index ****/
+
+// Per-world singleton. `moved` is a change-detecting query over everything
+// that feeds an entity's world bounds; see propagateTransforms. WorldBox and
+// the circle shape are only written, so they are `out` terms and writing them
+// doesn't mark a table as changed for this query.
+struct SpatialIndex {
+    flecs::query<
+        const Position,
+        const BoundingBox,
+        const Radius*,
+        const Rotation*,
+        const CollisionLayer*,
+        WorldBox,
+        sf::CircleShape*>
+               moved;
+    BroadPhase broadPhase;
+};
+
+void registerSpatialIndex(flecs::world& ecs) {
+    ecs.set(SpatialIndex{
+        .moved = ecs.query_builder<
+                        const Position, const BoundingBox, const Radius*,
+                        const Rotation*, const CollisionLayer*, WorldBox,
+                        sf::CircleShape*>()
+                     .term_at(5)
+                     .out()
+                     .term_at(6)
+                     .out()
+                     .cached()
+                     .detect_changes()
+                     .build()
+    });
+
+    // Entities leave the broad phase when they lose their world bounds or
+    // their collision layer; propagateTransforms only sees entities that
+    // still have one
+    auto removeFromBroadPhase = [](flecs::entity e) {
+        flecs::world ecs = e.world();
+        if (ecs.is_fini()) {
+            return;
+        }
+        if (SpatialIndex* index = ecs.get_mut<SpatialIndex>()) {
+            index->broadPhase.remove(e);
+        }
+    };
+    ecs.observer<WorldBox>()
+        .event(flecs::OnRemove)
+        .each([=](flecs::entity e, WorldBox&) { removeFromBroadPhase(e); });
+    ecs.observer<const CollisionLayer>()
+        .event(flecs::OnRemove)
+        .each([=](flecs::entity e, const CollisionLayer&) {
+            removeFromBroadPhase(e);
+        });
+}
+
+/**** Collision Detection ****/
+
+// Expects world bounds to be current (see propagateTransforms)
+void collisionDetection(flecs::world& ecs) {
+    BroadPhase& broadPhase = ecs.get_mut<SpatialIndex>()->broadPhase;
+    broadPhase.sort();
+
+    DeferGuard g(ecs);
+    broadPhase.pairs([](flecs::entity e1, flecs::entity e2) {
+        e1.add<CollidedWith>(e2);
+    });
+}
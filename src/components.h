@@ -1,10 +1,13 @@
 #pragma once
 
+#include <array>
+
 #include "utils/util.h"
 
 /**** New Type Components ****/
 
 NEWTYPE(Position, Vec2)
+NEWTYPE(PrevPosition, Vec2)  // Position at the start of the last tick
 NEWTYPE(Velocity, Vec2)
 NEWTYPE(Acceleration, Vec2)
 NEWTYPE(Mass, int)
@@ -21,6 +24,8 @@ struct Ship {};
 struct BoundingBox {
     Vec2 top, bot;
 
+    bool operator==(const BoundingBox&) const = default;
+
     void addPt(const Vec2& pt) {
         top = Vec2(std::min(top.x, pt.x), std::min(top.y, pt.y));
         bot = Vec2(std::max(bot.x, pt.x), std::max(bot.y, pt.y));
@@ -43,26 +48,65 @@ struct BoundingBox {
         return bot - top;
     }
 
-    void debug_draw() const {
-        drawer.lineStrip(
-            {top, Vec2(top.x, bot.y), bot, Vec2(bot.x, top.y), top},
-            sf::Color::Red, 0
-        );
+    void debug_draw(DebugDrawBuffer& debug) const {
+        std::array<Vec2, 5> pts = {
+            top, Vec2(top.x, bot.y), bot, Vec2(bot.x, top.y), top
+        };
+        debug.lineStrip(pts, sf::Color::Red, SIM_DEBUG_LAYER);
     }
 };
 
+// BoundingBox is always relative to Position; this is the same box in world
+// space, kept up to date by propagateTransforms.
+NEWTYPE(WorldBox, BoundingBox)
+
+/**** Collision Layers ****/
+
+enum CollisionCategory : uint32_t {
+    CollideAnomaloid  = 1 << 0,
+    CollideShip       = 1 << 1,
+    CollideProjectile = 1 << 2,
+};
+
+const int NUM_COLLISION_LAYERS = 3;
+
+// An entity sits on the layer of its (single bit) category. Two entities are
+// only tested against each other if each one's mask contains the other's
+// category. Entities without a CollisionLayer never collide.
+struct CollisionLayer {
+    uint32_t category;
+    uint32_t mask;
+};
+
+const CollisionLayer ANOMALOID_LAYER = {
+    .category = CollideAnomaloid,
+    .mask     = CollideAnomaloid | CollideShip | CollideProjectile
+};
+const CollisionLayer SHIP_LAYER = {
+    .category = CollideShip,
+    .mask     = CollideAnomaloid
+};
+const CollisionLayer PROJECTILE_LAYER = {
+    .category = CollideProjectile,
+    .mask     = CollideAnomaloid
+};
+
 /**** Registration ****/
 
 #define REGISTER_COMPONENT(TYPE) ecs.component<TYPE>(#TYPE)
 
 void registerComponents(flecs::world& ecs) {
     REGISTER_COMPONENT(Position);
+    REGISTER_COMPONENT(PrevPosition);
     REGISTER_COMPONENT(Velocity);
     REGISTER_COMPONENT(Acceleration);
     REGISTER_COMPONENT(Mass);
     REGISTER_COMPONENT(AnomalyMult);
     REGISTER_COMPONENT(Radius);
+    REGISTER_COMPONENT(Rotation);
     REGISTER_COMPONENT(BoundingBox);
+    REGISTER_COMPONENT(WorldBox);
+    REGISTER_COMPONENT(CollisionLayer);
     REGISTER_COMPONENT(sf::Color);
     REGISTER_COMPONENT(Ship);
 }
@@ -3,127 +3,182 @@
 
 #include <SFML/Graphics.hpp>
 
+#include <algorithm>
+#include <charconv>
+#include <string_view>
+
 #include "anomaloid.h"
 #include "components.h"
+#include "sim.h"
 #include "utils/util.h"
+#include "world_host.h"
 
-void spawnShip(flecs::world& ecs, Position pos) {
-    BoundingBox box = {.top = {0, 0}, .bot = {0, 0}};
-
-    int             i = 0;
-    sf::ConvexShape gfx(5);
-    for (Vec2 pt :
-         {Vec2(0, -10), Vec2(8, 10), Vec2(2, 8), Vec2(-2, 8), Vec2(-8, 10)}) {
-        gfx.setPoint(i++, pt);
-        box.addPt(pt);
-        fmt::println("Adding point: {}", pt);
-        fmt::println("{}, {}", box.top, box.bot);
-    }
-
-    gfx.setFillColor(sf::Color::Green);
-    gfx.setOutlineColor(sf::Color(150, 150, 150));
-    gfx.setOutlineThickness(1);
-
-    ecs.entity()
-        .add<Ship>()
-        .set(pos)
-        .set(Velocity({0, 0}))
-        .set(Acceleration({0, 0}))
-        .set(Mass(5))
-        .set(gfx)
-        .set(box);
-}
-
-void spawnBullet(flecs::world& ecs, Position pos, Velocity vel) {
-    int                i    = 0;
-    Vec2               size = {4, 10};
-    BoundingBox        box  = {.top = -size / 2.f, .bot = size / 2.f};
-    sf::RectangleShape gfx(size);
-
-    gfx.setOrigin(size.x / 2, size.y / 2);
-    gfx.setFillColor(sf::Color::White);
-    gfx.setOutlineColor(sf::Color::Black);
-    gfx.setOutlineThickness(1);
-
-    ecs.entity()
-        .set(pos)
-        .set(vel)
-        .set(Acceleration({0, 0}))
-        .set(Mass(1))
-        .set(gfx)
-        .set(box);
+void renderBullet(flecs::world& ecs, sf::RenderTarget& window, float alpha) {
+    ecs.each([&](const Position& pos, const PrevPosition& prev,
+                 sf::RectangleShape& gfx) {
+        gfx.setPosition(lerp(prev.v, pos.v, alpha));
+        window.draw(gfx);
+    });
 }
 
-void renderBullet(flecs::world& ecs, sf::RenderTarget& window) {
-    ecs.each([&](const Position& pos, sf::RectangleShape& gfx) {
-        gfx.setPosition(pos.v);
+void renderShip(flecs::world& ecs, sf::RenderTarget& window, float alpha) {
+    ecs.each([&](const Ship, const Position& pos, const PrevPosition& prev,
+                 sf::ConvexShape& gfx) {
+        gfx.setPosition(lerp(prev.v, pos.v, alpha));
         window.draw(gfx);
     });
 }
 
-void applyGravity(flecs::world& ecs, float dt) {
-    const float G = 0.001;
-    ecs.each([&](flecs::entity e, const Position& pos, Acceleration& acc,
-                 const Mass& _mass) {
-        ecs.each([&](flecs::entity other, const Position& otherPos,
-                     const Mass& otherMass) {
-            if (e == other) {
-                return;
-            }
-            auto dist = magnitude(otherPos.v - pos.v);
-            auto dir  = ((otherPos.v - pos.v) / dist);
-            acc.v += dir * G * (float)(otherMass.v / (dist * dist));
+// Debug visualization runs as multi-threaded systems during ecs.progress().
+// Each stage records into its own buffer; DebugDraw::flush merges them.
+void registerDebugDrawSystems(flecs::world& ecs) {
+    DebugDraw& debugDraw = worldCtx(ecs).debugDraw;
+
+    ecs.system<const WorldBox>("DebugBoundingBoxes")
+        .multi_threaded()
+        .each([&debugDraw](flecs::iter& it, size_t i, const WorldBox& box) {
+            AllocScope       scope(Subsystem::DebugDraw);
+            DebugDrawBuffer& debug =
+                debugDraw.forStage(it.world().get_stage_id());
+            debug.begin(it.entity(i).id(), it.system().id());
+            box.v.debug_draw(debug);
+        });
+
+    ecs.system<const Position, const Mass, const AnomalyMult>(
+           "DebugAnomaloidLabels"
+    )
+        .multi_threaded()
+        .each([&debugDraw](
+                  flecs::iter& it, size_t i, const Position& pos,
+                  const Mass& mass, const AnomalyMult&
+              ) {
+            AllocScope       scope(Subsystem::DebugDraw);
+            flecs::entity    e = it.entity(i);
+            DebugDrawBuffer& debug =
+                debugDraw.forStage(it.world().get_stage_id());
+            debug.begin(e.id(), it.system().id());
+            debug.label({.pos = pos.v, .color = sf::Color::Black}, e);
+            debug.label(
+                {.pos = pos.v + Vec2(0, 20), .color = sf::Color::Black}, mass
+            );
         });
-    });
 }
 
-void updatePhysicsMechanics(flecs::world& ecs, float dt) {
-    ecs.each([&](flecs::entity e, Position& pos, Velocity& vel,
-                 Acceleration& acc) {
-        fmt::println("{}, entity: {}", acc, e);
-        vel.v += acc.v * dt;
-        pos.v += vel.v * dt;
-        acc.v = {0, 0};
-    });
+sf::View initWindow(sf::RenderWindow& window);
+
+struct Args {
+    int         worlds  = 0;  // > 0 runs that many headless worlds instead
+    int         ticks   = 600;
+    int         threads = std::thread::hardware_concurrency();
+    std::string stream;     // Unix socket path for the state stream
+    std::string memReport;  // JSON lines file written after a headless run
+};
+
+Args parseArgs(int argc, char** argv) {
+    Args args;
+    for (int i = 1; i < argc; i += 2) {
+        std::string_view flag = argv[i];
+        if (i + 1 == argc) {
+            throw std::runtime_error(fmt::format("Bad argument: {}", flag));
+        }
+        std::string_view value = argv[i + 1];
+        if (flag == "--stream" || flag == "--mem-report") {
+            (flag == "--stream" ? args.stream : args.memReport) = value;
+            continue;
+        }
+        int* out = flag == "--worlds"    ? &args.worlds
+                   : flag == "--ticks"   ? &args.ticks
+                   : flag == "--threads" ? &args.threads
+                                         : nullptr;
+        if (!out ||
+            std::from_chars(value.data(), value.data() + value.size(), *out)
+                    .ec != std::errc()) {
+            throw std::runtime_error(
+                fmt::format("Bad argument: {} {}", flag, value)
+            );
+        }
+    }
+    return args;
 }
 
-void renderShip(flecs::world& ecs, sf::RenderTarget& window) {
-    ecs.each([&](const Ship, const Position& pos, sf::ConvexShape& gfx) {
-        gfx.setPosition(pos.v);
-        window.draw(gfx);
-    });
+// One line per world with its ECS memory, then one with the allocation
+// totals of the run
+void writeMemReport(
+    const std::string& path,
+    WorldHost&         host,
+    const AllocTotals& allocs
+) {
+    std::FILE* out = std::fopen(path.c_str(), "w");
+    if (!out) {
+        throw std::runtime_error("Failed to open " + path);
+    }
+    for (size_t i = 0; i < host.sims.size(); ++i) {
+        fmt::print(out, "{{\"world\":{},\"memory\":", i);
+        host.sims[i]->memory.report().writeJson(out);
+        fmt::print(out, "}}\n");
+    }
+    fmt::print(out, "{{\"allocs\":");
+    allocs.writeJson(out);
+    fmt::print(out, "}}\n");
+    std::fclose(out);
 }
 
-void renderBoundingBoxes(flecs::world& ecs, sf::RenderTarget& window) {
-    ecs.each([&](const BoundingBox& box) { box.debug_draw(); });
+void runHeadless(const Args& args) {
+    WorldHost host(
+        args.worlds, SimConfig{.streamPath = args.stream}, args.threads
+    );
+    fmt::println(
+        "Running {} worlds for {} ticks on {} threads", args.worlds,
+        args.ticks, host.pool.size()
+    );
+
+    AllocTotals allocs;
+    allocCounters.lap();
+
+    // Worlds only sync between chunks, where the allocation counters are read
+    const int chunk = 60;
+    auto      start = now();
+    for (int t = 0; t < args.ticks; t += chunk) {
+        int ticks = std::min(chunk, args.ticks - t);
+        host.run(ticks);
+        allocs.add(allocCounters.lap(), ticks);
+    }
+    std::chrono::duration<double> elapsed = now() - start;
+
+    host.report();
+    fmt::println(
+        "{:.2f} s wall, {:.0f} world-ticks/s, {:.1f} heap allocs/tick",
+        elapsed.count(), args.worlds * args.ticks / elapsed.count(),
+        double(allocs.total.allocs) / args.ticks
+    );
+
+    if (!args.memReport.empty()) {
+        writeMemReport(args.memReport, host, allocs);
+    }
 }
 
-sf::View initWindow(sf::RenderWindow& window);
+int main(int argc, char** argv) {
+    countEcsAllocs();
+    Args args = parseArgs(argc, argv);
+    if (args.worlds > 0) {
+        runHeadless(args);
+        return 0;
+    }
 
-int main() {
     auto      window = sf::RenderWindow{{1920u, 1080u}, "Base Template"};
     sf::View  view   = initWindow(window);
     sf::Clock frameClock;
 
-    flecs::world ecs;
-    registerComponents(ecs);
-    registerRelations(ecs);
+    Sim sim(SimConfig{.threads = args.threads, .streamPath = args.stream});
+    flecs::world& ecs        = sim.ecs;
+    TextDrawer&   textDrawer = sim.ctx.textDrawer;
     ecs.set<flecs::Rest>({});
+    registerDebugDrawSystems(ecs);
+    sim.spawnScenario();
 
-    spawnAnomaloids(ecs, 10);
-    spawnShip(ecs, Position({0, 0}));
-
-    spawnBullet(ecs, Position({0, 0}), Velocity({0.05, 0}));
-    spawnBullet(ecs, Position({0, 0}), Velocity({0.00, 0}));
-
-    for (int i = 0; i < 2; ++i) {
-        for (int j = 0; j < 2; ++j) {
-            spawnBullet(
-                ecs, Position({-100.f + i * 20, -100.f + j * 20}),
-                Velocity({0.05, 0})
-            );
-        }
-    }
+    AllocCounters::Snapshot lastFrameAllocs;
+    std::string             memOverlay;
+    bool                    showMemOverlay = false;
 
     for (int frame = 0; window.isOpen(); ++frame) {
         sf::Time deltaTime = frameClock.restart();
@@ -144,6 +199,8 @@ int main() {
                 case sf::Event::KeyPressed:
                     if (event.key.code == sf::Keyboard::Escape) {
                         window.close();
+                    } else if (event.key.code == sf::Keyboard::F3) {
+                        showMemOverlay = !showMemOverlay;
                     }
                     break;
                 default:
@@ -151,22 +208,45 @@ int main() {
             }
         }
 
-        // applyGravity(ecs, deltaTime.asMilliseconds());
-        updatePhysicsMechanics(ecs, deltaTime.asMilliseconds());
+        sim.advance(deltaTime.asSeconds());
 
-        collisionDetection(ecs);
-
-        renderAnomaloids(ecs, window);
-        renderBoundingBoxes(ecs, window);
-        renderShip(ecs, window);
-        renderBullet(ecs, window);
+        {
+            AllocScope scope(Subsystem::Render);
+            renderAnomaloids(ecs, window);
+            renderShip(ecs, window, sim.scheduler.alpha);
+            renderBullet(ecs, window, sim.scheduler.alpha);
+        }
 
         // ensure that the rest system is run (and any user defined systems)
         ecs.progress(deltaTime.asSeconds());
+        {
+            AllocScope scope(Subsystem::DebugDraw);
+            sim.ctx.debugDraw.flush(sim.ctx.drawer, textDrawer);
+        }
+
+        {
+            AllocScope scope(Subsystem::Text);
+            if (showMemOverlay && (memOverlay.empty() || frame % 30 == 0)) {
+                memOverlay = sim.memory.report().overlay();
+            }
+            textDrawer.draw(
+                {.pos      = view.getCenter() - view.getSize() / 2.f +
+                             Vec2(10, 10),
+                 .color    = sf::Color::Yellow,
+                 .centered = std::nullopt},
+                allocOverlay(lastFrameAllocs), showMemOverlay ? memOverlay : ""
+            );
+            textDrawer.display(window);
+        }
+
+        {
+            AllocScope scope(Subsystem::Render);
+            sim.ctx.drawer.display(window);
+            window.display();
+        }
 
-        textDrawer.display(window);
-        drawer.display(window);
-        window.display();
+        lastFrameAllocs = allocCounters.lap();
+        resetFrameArenas();
     }
 }
 
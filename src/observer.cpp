@@ -0,0 +1,103 @@
+#include <flecs.h>
+#include <fmt/core.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+#include "components.h"
+#include "state_stream.h"
+#include "utils/util.h"
+
+// Local observer for the state stream: connects to a simulation's socket and
+// rebuilds its Position/Velocity state in a flecs world of its own.
+//
+//   ./build/StateObserver /tmp/dirac.sock
+
+struct WorldMirror {
+    flecs::world&                               ecs;
+    std::unordered_map<uint64_t, flecs::entity> entities;
+    uint64_t                                    tick      = 0;
+    uint64_t                                    messages  = 0;
+    uint64_t                                    keyframes = 0;
+
+    void onMessage(StreamMsg kind, uint64_t tick) {
+        this->tick = tick;
+        ++this->messages;
+        this->keyframes += kind == StreamMsg::Keyframe;
+    }
+
+    void onCreated(uint64_t id, const StreamState& s) {
+        this->entities[id] =
+            this->ecs.entity().set(s.position()).set(s.velocity());
+    }
+
+    void onUpdated(uint64_t id, const StreamState& s) {
+        this->entities.at(id).set(s.position()).set(s.velocity());
+    }
+
+    void onDestroyed(uint64_t id) {
+        if (auto it = this->entities.find(id); it != this->entities.end()) {
+            it->second.destruct();
+            this->entities.erase(it);
+        }
+    }
+};
+
+int connectTo(const std::string& path) {
+    sockaddr_un addr{.sun_family = AF_UNIX};
+    if (path.size() >= sizeof(addr.sun_path)) {
+        throw std::runtime_error("Socket path too long: " + path);
+    }
+    std::strcpy(addr.sun_path, path.c_str());
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || ::connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+        throw std::runtime_error(
+            "Failed to connect to " + path + ": " + std::strerror(errno)
+        );
+    }
+    return fd;
+}
+
+int main(int argc, char** argv) {
+    std::string path = argc > 1 ? argv[1] : "/tmp/dirac.sock";
+    int         fd   = connectTo(path);
+
+    flecs::world ecs;
+    registerComponents(ecs);
+
+    WorldMirror        mirror{ecs};
+    StateStreamDecoder decoder;
+
+    uint8_t  buf[64 * 1024];
+    uint64_t bytes = 0, reportedBytes = 0, reportedMessages = 0;
+    auto     lastReport = now();
+
+    ssize_t n;
+    while ((n = ::read(fd, buf, sizeof(buf))) > 0) {
+        decoder.feed(buf, n, mirror);
+        bytes += n;
+
+        std::chrono::duration<double> sinceReport = now() - lastReport;
+        if (sinceReport.count() >= 1) {
+            uint64_t msgs = mirror.messages - reportedMessages;
+            fmt::println(
+                "tick {:6} | {:6} entities | {:4} msgs ({} keyframes total) "
+                "| {:8.1f} B/tick",
+                mirror.tick, ecs.count<Position>(), msgs, mirror.keyframes,
+                msgs ? double(bytes - reportedBytes) / msgs : 0.
+            );
+            reportedBytes    = bytes;
+            reportedMessages = mirror.messages;
+            lastReport       = now();
+        }
+    }
+
+    fmt::println("Stream closed after {} bytes", bytes);
+    ::close(fd);
+}
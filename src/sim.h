@@ -0,0 +1,193 @@
+#pragma once
+
+#include <flecs.h>
+
+#include <SFML/Graphics.hpp>
+#include <memory>
+#include <string>
+
+#include "anomaloid.h"
+#include "components.h"
+#include "state_stream.h"
+#include "transform.h"
+#include "utils/util.h"
+
+/**** Spawning ****/
+
+void spawnShip(flecs::world& ecs, Position pos) {
+    BoundingBox box = {.top = {0, 0}, .bot = {0, 0}};
+
+    int             i = 0;
+    sf::ConvexShape gfx(5);
+    for (Vec2 pt :
+         {Vec2(0, -10), Vec2(8, 10), Vec2(2, 8), Vec2(-2, 8), Vec2(-8, 10)}) {
+        gfx.setPoint(i++, pt);
+        box.addPt(pt);
+    }
+
+    gfx.setFillColor(sf::Color::Green);
+    gfx.setOutlineColor(sf::Color(150, 150, 150));
+    gfx.setOutlineThickness(1);
+
+    ecs.entity()
+        .add<Ship>()
+        .set(pos)
+        .set(PrevPosition(pos.v))
+        .set(Velocity({0, 0}))
+        .set(Acceleration({0, 0}))
+        .set(Mass(5))
+        .set(gfx)
+        .set(box)
+        .add<WorldBox>()
+        .set(SHIP_LAYER);
+}
+
+void spawnBullet(flecs::world& ecs, Position pos, Velocity vel) {
+    Vec2               size = {4, 10};
+    BoundingBox        box  = {.top = -size / 2.f, .bot = size / 2.f};
+    sf::RectangleShape gfx(size);
+
+    gfx.setOrigin(size.x / 2, size.y / 2);
+    gfx.setFillColor(sf::Color::White);
+    gfx.setOutlineColor(sf::Color::Black);
+    gfx.setOutlineThickness(1);
+
+    ecs.entity()
+        .set(pos)
+        .set(PrevPosition(pos.v))
+        .set(vel)
+        .set(Acceleration({0, 0}))
+        .set(Mass(1))
+        .set(gfx)
+        .set(box)
+        .add<WorldBox>()
+        .set(PROJECTILE_LAYER);
+}
+
+/**** Physics ****/
+
+void applyGravity(flecs::world& ecs, float dt) {
+    const float G = 0.001;
+    ecs.each([&](flecs::entity e, const Position& pos, Acceleration& acc,
+                 const Mass& _mass) {
+        ecs.each([&](flecs::entity other, const Position& otherPos,
+                     const Mass& otherMass) {
+            if (e == other) {
+                return;
+            }
+            auto dist = magnitude(otherPos.v - pos.v);
+            auto dir  = ((otherPos.v - pos.v) / dist);
+            acc.v += dir * G * (float)(otherMass.v / (dist * dist));
+        });
+    });
+}
+
+void storePrevPositions(flecs::world& ecs) {
+    ecs.each([](PrevPosition& prev, const Position& pos) { prev.v = pos.v; });
+}
+
+void updatePhysicsMechanics(flecs::world& ecs, float dt) {
+    ecs.each([&](Position& pos, Velocity& vel, Acceleration& acc) {
+        vel.v += acc.v * dt;
+        pos.v += vel.v * dt;
+        acc.v = {0, 0};
+    });
+}
+
+/**** Simulation ****/
+
+struct SimConfig {
+    uint32_t  seed        = std::random_device{}();
+    int       anomaloids  = 10;
+    float     tickRate    = 60;  // ticks per second
+    int       maxSubsteps = 4;
+    int       threads     = 1;  // flecs worker threads for systems
+    Placement placement   = Placement::PoissonDisk;  // anomaloid spawn
+    // Leave empty for headless worlds, which never draw text
+    std::string fontPath = "./open-sans/OpenSans-Bold.ttf";
+    // Unix socket to stream state changes on, empty to disable
+    std::string streamPath;
+};
+
+// One isolated simulation: a flecs world plus everything it used to share
+// with the rest of the process.
+struct Sim {
+    SimConfig          config;
+    WorldCtx           ctx;
+    flecs::world       ecs;
+    FixedStepScheduler scheduler;
+
+    std::unique_ptr<StateStreamServer> stream;
+    MemoryStats                        memory;
+
+    Sim(const SimConfig& config)
+        : config(config)
+        , ctx(config.seed, config.fontPath)
+        , scheduler(config.tickRate, config.maxSubsteps)
+        , memory(this->ecs) {
+        this->ecs.set_ctx(&this->ctx);
+        if (config.threads > 1) {
+            this->ecs.set_threads(config.threads);
+        }
+        this->ctx.debugDraw.resize(this->ecs.get_stage_count());
+        registerComponents(this->ecs);
+        registerRelations(this->ecs);
+        registerSpatialIndex(this->ecs);
+        registerAnomaloidColors(this->ecs);
+        if (!config.streamPath.empty()) {
+            this->stream = std::make_unique<StateStreamServer>(
+                this->ecs, config.streamPath
+            );
+        }
+    }
+
+    Sim(const Sim&)            = delete;
+    Sim& operator=(const Sim&) = delete;
+
+    void spawnScenario() {
+        spawnAnomaloids(
+            this->ecs, this->config.anomaloids, this->config.placement
+        );
+        spawnShip(this->ecs, Position({0, 0}));
+
+        spawnBullet(this->ecs, Position({0, 0}), Velocity({0.05, 0}));
+        spawnBullet(this->ecs, Position({0, 0}), Velocity({0.00, 0}));
+
+        for (int i = 0; i < 2; ++i) {
+            for (int j = 0; j < 2; ++j) {
+                spawnBullet(
+                    this->ecs, Position({-100.f + i * 20, -100.f + j * 20}),
+                    Velocity({0.05, 0})
+                );
+            }
+        }
+    }
+
+    // A single fixed tick
+    void tick(float tickSeconds) {
+        // velocities are in px/ms
+        const float dt = tickSeconds * 1000;
+        {
+            AllocScope scope(Subsystem::Physics);
+            storePrevPositions(this->ecs);
+            // applyGravity(this->ecs, dt);
+            updatePhysicsMechanics(this->ecs, dt);
+        }
+        {
+            AllocScope scope(Subsystem::Collision);
+            propagateTransforms(this->ecs);
+            collisionDetection(this->ecs);
+        }
+        if (this->stream) {
+            AllocScope scope(Subsystem::Stream);
+            this->stream->publish(this->scheduler.tick);
+        }
+    }
+
+    // Runs however many fixed ticks are due after `frameSeconds`
+    int advance(float frameSeconds) {
+        return this->scheduler.advance(frameSeconds, [this](float dt) {
+            this->tick(dt);
+        });
+    }
+};
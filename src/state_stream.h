@@ -0,0 +1,517 @@
+#pragma once
+
+#include <fcntl.h>
+#include <flecs.h>
+#include <fmt/core.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "components.h"
+#include "utils/util.h"
+
+/**** Wire Format ****/
+
+// A stream is a sequence of messages, each prefixed by its length as a
+// little-endian u32. A message is
+//
+//   u8     kind            (keyframe or delta)
+//   varint tick
+//   varint numCreated,   then per entity: id, pos.x, pos.y, vel.x, vel.y
+//   varint numUpdated,   then per entity: id, u8 fields, changed fields
+//   varint numDestroyed, then per entity: id
+//
+// Ids are sorted and sent as the difference from the previous id in the same
+// section. Created entities carry absolute values; updated entities carry the
+// difference from the last value sent. All values are quantized and
+// zigzag-varint encoded, so a body that barely moved costs a few bytes and
+// one that didn't move costs nothing. A keyframe is a message with only
+// created entities; the receiver drops everything it had before applying it.
+
+enum class StreamMsg : uint8_t {
+    Keyframe = 1,
+    Delta    = 2,
+};
+
+enum StreamField : uint8_t {
+    FieldPosition = 1 << 0,
+    FieldVelocity = 1 << 1,
+};
+
+const float STREAM_POS_SCALE = 16;    // 1/16 px
+const float STREAM_VEL_SCALE = 4096;  // 1/4096 px/ms
+
+struct StreamState {
+    int32_t px = 0, py = 0;
+    int32_t vx = 0, vy = 0;
+
+    static StreamState quantize(const Position& pos, const Velocity* vel) {
+        StreamState s;
+        s.px = std::lround(pos.v.x * STREAM_POS_SCALE);
+        s.py = std::lround(pos.v.y * STREAM_POS_SCALE);
+        if (vel) {
+            s.vx = std::lround(vel->v.x * STREAM_VEL_SCALE);
+            s.vy = std::lround(vel->v.y * STREAM_VEL_SCALE);
+        }
+        return s;
+    }
+
+    Position position() const {
+        return Position(Vec2(px, py) / STREAM_POS_SCALE);
+    }
+
+    Velocity velocity() const {
+        return Velocity(Vec2(vx, vy) / STREAM_VEL_SCALE);
+    }
+
+    uint8_t diff(const StreamState& o) const {
+        return (px != o.px || py != o.py ? FieldPosition : 0) |
+               (vx != o.vx || vy != o.vy ? FieldVelocity : 0);
+    }
+};
+
+struct StreamEntity {
+    uint64_t    id;
+    StreamState state;
+};
+
+struct ByteWriter {
+    std::vector<uint8_t>& out;
+
+    void u8(uint8_t v) {
+        this->out.push_back(v);
+    }
+
+    void varint(uint64_t v) {
+        while (v >= 0x80) {
+            this->out.push_back(uint8_t(v) | 0x80);
+            v >>= 7;
+        }
+        this->out.push_back(uint8_t(v));
+    }
+
+    void zigzag(int64_t v) {
+        this->varint((uint64_t(v) << 1) ^ uint64_t(v >> 63));
+    }
+};
+
+struct ByteReader {
+    const uint8_t* p;
+    const uint8_t* end;
+
+    uint8_t u8() {
+        if (this->p == this->end) {
+            throw std::runtime_error("State stream: truncated message");
+        }
+        return *this->p++;
+    }
+
+    uint64_t varint() {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t b = this->u8();
+            v |= uint64_t(b & 0x7f) << shift;
+            if (!(b & 0x80)) {
+                return v;
+            }
+        }
+        throw std::runtime_error("State stream: bad varint");
+    }
+
+    int64_t zigzag() {
+        uint64_t v = this->varint();
+        return int64_t(v >> 1) ^ -int64_t(v & 1);
+    }
+};
+
+/**** Server ****/
+
+// Streams Position/Velocity changes of one world to any number of local
+// observers connected to a Unix socket. New observers get a keyframe on their
+// first tick; everyone gets one every `keyframeInterval` ticks. Observers that
+// fall more than `maxBacklog` bytes behind are dropped.
+//
+// Per tick, only tables whose Position or Velocity changed are read, and the
+// last sent state of each entity is kept in a map updated in place, so a
+// world where little moved costs little. Only keyframes walk every entity.
+struct StateStreamServer {
+    struct Client {
+        int                  fd;
+        bool                 needsKeyframe = true;
+        std::vector<uint8_t> outbox;  // not yet sent
+    };
+
+    struct Update {
+        uint64_t    id;
+        StreamState now, prev;
+    };
+
+    std::string                                   path;
+    int                                           listenFd = -1;
+    std::vector<Client>                           clients;
+    flecs::query<const Position, const Velocity*> query;
+    flecs::observer                               onRemove;
+    // Last state sent per entity; complete while `synced`
+    std::unordered_map<uint64_t, StreamState> baseline;
+    bool                                      synced = false;
+    std::vector<uint64_t>                     removed;  // since last publish
+    std::vector<uint8_t>                      keyframe, delta;
+    uint32_t                                  keyframeInterval;
+    size_t                                    maxBacklog = 16 << 20;
+
+    StateStreamServer(
+        flecs::world&      ecs,
+        const std::string& path,
+        uint32_t           keyframeInterval = 300
+    )
+        : path(path), keyframeInterval(keyframeInterval) {
+        this->query = ecs.query_builder<const Position, const Velocity*>()
+                          .cached()
+                          .detect_changes()
+                          .build();
+        this->onRemove = ecs.observer<const Position>()
+                             .event(flecs::OnRemove)
+                             .each([this](flecs::entity e, const Position&) {
+                                 if (this->synced) {
+                                     this->removed.push_back(e.id());
+                                 }
+                             });
+
+        sockaddr_un addr{.sun_family = AF_UNIX};
+        if (path.size() >= sizeof(addr.sun_path)) {
+            throw std::runtime_error("State stream: socket path too long");
+        }
+        std::strcpy(addr.sun_path, path.c_str());
+        ::unlink(path.c_str());
+
+        this->listenFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        if (this->listenFd < 0 ||
+            ::bind(this->listenFd, (sockaddr*)&addr, sizeof(addr)) < 0 ||
+            ::listen(this->listenFd, 8) < 0) {
+            throw std::runtime_error(
+                "State stream: failed to listen on " + path + ": " +
+                std::strerror(errno)
+            );
+        }
+    }
+
+    ~StateStreamServer() {
+        this->onRemove.destruct();
+        for (Client& c : this->clients) {
+            ::close(c.fd);
+        }
+        ::close(this->listenFd);
+        ::unlink(this->path.c_str());
+    }
+
+    StateStreamServer(const StateStreamServer&)            = delete;
+    StateStreamServer& operator=(const StateStreamServer&) = delete;
+
+    void publish(uint64_t tick) {
+        this->acceptClients();
+        if (this->clients.empty()) {
+            this->baseline.clear();
+            this->removed.clear();
+            this->synced = false;
+            return;
+        }
+
+        // Without a baseline every table is read, and everyone gets a keyframe
+        bool                           wasSynced = this->synced;
+        std::pmr::vector<StreamEntity> created(frameArena());
+        std::pmr::vector<Update>       updated(frameArena());
+        std::pmr::vector<uint64_t>     destroyed(frameArena());
+
+        for (uint64_t id : this->removed) {
+            if (this->baseline.erase(id)) {
+                destroyed.push_back(id);
+            }
+        }
+        this->removed.clear();
+
+        this->query.run([&](flecs::iter& it) {
+            while (it.next()) {
+                if (wasSynced && !it.changed()) {
+                    it.skip();
+                    continue;
+                }
+                auto pos = it.field<const Position>(0);
+                auto vel = it.field<const Velocity>(1);
+                for (auto i : it) {
+                    uint64_t    id  = it.entity(i).id();
+                    StreamState now = StreamState::quantize(
+                        pos[i], it.is_set(1) ? &vel[i] : nullptr
+                    );
+                    auto [slot, inserted] = this->baseline.try_emplace(id, now);
+                    if (inserted) {
+                        created.push_back({id, now});
+                    } else if (now.diff(slot->second)) {
+                        updated.push_back({id, now, slot->second});
+                        slot->second = now;
+                    }
+                }
+            }
+        });
+        this->synced = true;
+
+        auto byId = [](auto& a, auto& b) { return a.id < b.id; };
+        std::sort(created.begin(), created.end(), byId);
+        std::sort(updated.begin(), updated.end(), byId);
+        std::sort(destroyed.begin(), destroyed.end());
+
+        bool periodic =
+            this->keyframeInterval && tick % this->keyframeInterval == 0;
+        bool anyKeyframe = periodic, anyDelta = false;
+        for (Client& c : this->clients) {
+            c.needsKeyframe |= periodic || !wasSynced;
+            anyKeyframe |= c.needsKeyframe;
+            anyDelta |= !c.needsKeyframe;
+        }
+        if (anyKeyframe) {
+            this->encodeKeyframe(tick);
+        }
+        if (anyDelta) {
+            this->encodeDelta(tick, created, updated, destroyed);
+        }
+
+        for (Client& c : this->clients) {
+            const auto& msg = c.needsKeyframe ? this->keyframe : this->delta;
+            c.outbox.insert(c.outbox.end(), msg.begin(), msg.end());
+            c.needsKeyframe = false;
+            this->flush(c);
+        }
+        std::erase_if(this->clients, [](const Client& c) {
+            return c.fd < 0;
+        });
+    }
+
+   private:
+    void acceptClients() {
+        int fd;
+        while ((fd = ::accept4(this->listenFd, nullptr, nullptr, SOCK_NONBLOCK)
+               ) >= 0) {
+            this->clients.push_back({.fd = fd});
+        }
+    }
+
+    void flush(Client& c) {
+        size_t sent = 0;
+        while (sent < c.outbox.size()) {
+            ssize_t n = ::send(
+                c.fd, c.outbox.data() + sent, c.outbox.size() - sent,
+                MSG_NOSIGNAL
+            );
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    break;
+                }
+                ::close(c.fd);
+                c.fd = -1;
+                return;
+            }
+            sent += n;
+        }
+
+        // Drop what went out, so a client that keeps up on average never
+        // accumulates its already-sent prefix
+        c.outbox.erase(c.outbox.begin(), c.outbox.begin() + sent);
+        if (c.outbox.size() > this->maxBacklog) {
+            fmt::println("[StateStream] Dropping slow observer {}", c.fd);
+            ::close(c.fd);
+            c.fd = -1;
+        }
+    }
+
+    static void beginMessage(
+        std::vector<uint8_t>& out,
+        StreamMsg             kind,
+        uint64_t              tick
+    ) {
+        out.assign(4, 0);  // length, patched by endMessage
+        ByteWriter w{out};
+        w.u8(uint8_t(kind));
+        w.varint(tick);
+    }
+
+    static void endMessage(std::vector<uint8_t>& out) {
+        uint32_t len = out.size() - 4;
+        for (int i = 0; i < 4; ++i) {
+            out[i] = uint8_t(len >> (8 * i));
+        }
+    }
+
+    static void
+    writeCreated(ByteWriter& w, uint64_t& prevId, const StreamEntity& e) {
+        w.varint(e.id - prevId);
+        prevId = e.id;
+        w.zigzag(e.state.px);
+        w.zigzag(e.state.py);
+        w.zigzag(e.state.vx);
+        w.zigzag(e.state.vy);
+    }
+
+    // Every entity, from the (current) baseline
+    void encodeKeyframe(uint64_t tick) {
+        std::pmr::vector<StreamEntity> all(frameArena());
+        all.reserve(this->baseline.size());
+        for (const auto& [id, state] : this->baseline) {
+            all.push_back({id, state});
+        }
+        std::sort(all.begin(), all.end(), [](auto& a, auto& b) {
+            return a.id < b.id;
+        });
+
+        beginMessage(this->keyframe, StreamMsg::Keyframe, tick);
+        ByteWriter w{this->keyframe};
+        uint64_t   prevId = 0;
+        w.varint(all.size());
+        for (const StreamEntity& e : all) {
+            writeCreated(w, prevId, e);
+        }
+        w.varint(0);
+        w.varint(0);
+        endMessage(this->keyframe);
+    }
+
+    // All three lists sorted by id
+    void encodeDelta(
+        uint64_t                              tick,
+        const std::pmr::vector<StreamEntity>& created,
+        const std::pmr::vector<Update>&       updated,
+        const std::pmr::vector<uint64_t>&     destroyed
+    ) {
+        beginMessage(this->delta, StreamMsg::Delta, tick);
+        ByteWriter w{this->delta};
+
+        uint64_t prevId = 0;
+        w.varint(created.size());
+        for (const StreamEntity& e : created) {
+            writeCreated(w, prevId, e);
+        }
+
+        prevId = 0;
+        w.varint(updated.size());
+        for (const Update& u : updated) {
+            uint8_t mask = u.now.diff(u.prev);
+            w.varint(u.id - prevId);
+            prevId = u.id;
+            w.u8(mask);
+            if (mask & FieldPosition) {
+                w.zigzag(int64_t(u.now.px) - u.prev.px);
+                w.zigzag(int64_t(u.now.py) - u.prev.py);
+            }
+            if (mask & FieldVelocity) {
+                w.zigzag(int64_t(u.now.vx) - u.prev.vx);
+                w.zigzag(int64_t(u.now.vy) - u.prev.vy);
+            }
+        }
+
+        prevId = 0;
+        w.varint(destroyed.size());
+        for (uint64_t id : destroyed) {
+            w.varint(id - prevId);
+            prevId = id;
+        }
+        endMessage(this->delta);
+    }
+};
+
+/**** Client ****/
+
+// Rebuilds the streamed state. Feed it raw bytes from the socket; for every
+// complete message it calls the handler's `onMessage(kind, tick)`, then
+// `onCreated(id, state)`, `onUpdated(id, state)` and `onDestroyed(id)` per
+// entity.
+struct StateStreamDecoder {
+    std::vector<uint8_t>                      pending;
+    std::unordered_map<uint64_t, StreamState> states;
+
+    // Returns the number of complete messages decoded
+    template <typename Handler>
+    int feed(const uint8_t* data, size_t size, Handler& handler) {
+        this->pending.insert(this->pending.end(), data, data + size);
+
+        int    messages = 0;
+        size_t offset   = 0;
+        while (this->pending.size() - offset >= 4) {
+            const uint8_t* p   = this->pending.data() + offset;
+            uint32_t       len = p[0] | p[1] << 8 | p[2] << 16 | p[3] << 24;
+            if (this->pending.size() - offset - 4 < len) {
+                break;
+            }
+            this->decode({p + 4, p + 4 + len}, handler);
+            offset += 4 + len;
+            ++messages;
+        }
+        this->pending.erase(
+            this->pending.begin(), this->pending.begin() + offset
+        );
+        return messages;
+    }
+
+   private:
+    template <typename Handler>
+    void decode(ByteReader r, Handler& handler) {
+        StreamMsg kind = StreamMsg(r.u8());
+        uint64_t  tick = r.varint();
+        handler.onMessage(kind, tick);
+
+        if (kind == StreamMsg::Keyframe) {
+            for (auto& [id, _] : this->states) {
+                handler.onDestroyed(id);
+            }
+            this->states.clear();
+        } else if (kind != StreamMsg::Delta) {
+            throw std::runtime_error("State stream: unknown message kind");
+        }
+
+        uint64_t id = 0;
+        for (uint64_t n = r.varint(); n > 0; --n) {
+            id += r.varint();
+            StreamState s;
+            s.px = r.zigzag();
+            s.py = r.zigzag();
+            s.vx = r.zigzag();
+            s.vy = r.zigzag();
+            this->states[id] = s;
+            handler.onCreated(id, s);
+        }
+
+        id = 0;
+        for (uint64_t n = r.varint(); n > 0; --n) {
+            id += r.varint();
+            StreamState& s    = this->states.at(id);
+            uint8_t      mask = r.u8();
+            if (mask & FieldPosition) {
+                s.px += r.zigzag();
+                s.py += r.zigzag();
+            }
+            if (mask & FieldVelocity) {
+                s.vx += r.zigzag();
+                s.vy += r.zigzag();
+            }
+            handler.onUpdated(id, s);
+        }
+
+        id = 0;
+        for (uint64_t n = r.varint(); n > 0; --n) {
+            id += r.varint();
+            this->states.erase(id);
+            handler.onDestroyed(id);
+        }
+    }
+};
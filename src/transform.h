@@ -0,0 +1,91 @@
+#pragma once
+
+#include <flecs.h>
+
+#include <SFML/Graphics.hpp>
+#include <cmath>
+
+#include "collision.h"
+#include "components.h"
+#include "utils/util.h"
+
+/**** Transform Propagation ****/
+
+// Local bounds of a body: its Radius if it has one, otherwise its BoundingBox
+BoundingBox localBounds(const BoundingBox& box, const Radius* radius) {
+    if (!radius) {
+        return box;
+    }
+    return {
+        .top = Vec2(-radius->v, -radius->v),
+        .bot = Vec2(radius->v, radius->v)
+    };
+}
+
+// World-space AABB of a local box rotated by `rotation` and moved to `pos`
+BoundingBox
+worldBounds(const BoundingBox& local, const Position& pos, float rotation) {
+    if (rotation == 0) {
+        return {.top = local.top + pos.v, .bot = local.bot + pos.v};
+    }
+    float c       = std::cos(rotation);
+    float s       = std::sin(rotation);
+    auto  toWorld = [&](Vec2 p) {
+        return pos.v + Vec2(c * p.x - s * p.y, s * p.x + c * p.y);
+    };
+    Vec2        first = toWorld(local.top);
+    BoundingBox out   = {.top = first, .bot = first};
+    out.addPt(toWorld(Vec2(local.top.x, local.bot.y)));
+    out.addPt(toWorld(local.bot));
+    out.addPt(toWorld(Vec2(local.bot.x, local.top.y)));
+    return out;
+}
+
+// Updates derived state (world bounds, broad-phase entry, circle shape) of
+// entities whose Position, BoundingBox, Radius, Rotation or CollisionLayer
+// changed since the last call. Change detection is per table, not per entity:
+// a table nobody wrote to is skipped without touching its entities, but a
+// write to one entity (or a mutable iteration over the table) redoes all of
+// them. Static bodies in a table of their own cost nothing.
+void propagateTransforms(flecs::world& ecs) {
+    SpatialIndex* index = ecs.get_mut<SpatialIndex>();
+    index->moved.run([&](flecs::iter& it) {
+        while (it.next()) {
+            if (!it.changed()) {
+                it.skip();
+                continue;
+            }
+
+            auto pos    = it.field<const Position>(0);
+            auto box    = it.field<const BoundingBox>(1);
+            auto radius = it.field<const Radius>(2);
+            auto rot    = it.field<const Rotation>(3);
+            auto layer  = it.field<const CollisionLayer>(4);
+            auto world  = it.field<WorldBox>(5);
+            auto circle = it.field<sf::CircleShape>(6);
+
+            for (auto i : it) {
+                const Radius* r        = it.is_set(2) ? &radius[i] : nullptr;
+                float         rotation = it.is_set(3) ? rot[i].v : 0;
+
+                world[i].v =
+                    worldBounds(localBounds(box[i], r), pos[i], rotation);
+                if (it.is_set(4)) {
+                    index->broadPhase.upsert(
+                        it.entity(i), world[i].v, layer[i]
+                    );
+                }
+
+                if (it.is_set(6)) {
+                    sf::CircleShape& shape = circle[i];
+                    if (r && shape.getRadius() != r->v) {
+                        shape.setRadius(r->v);
+                        shape.setOrigin(r->v, r->v);
+                    }
+                    shape.setPosition(pos[i].v);
+                    shape.setRotation(rotation * 180 / 3.14159265f);
+                }
+            }
+        }
+    });
+}
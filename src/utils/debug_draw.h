@@ -0,0 +1,197 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "frame_arena.h"
+#include "layered_drawer.h"
+#include "text.h"
+#include "vectors.h"
+
+/**** Debug Draw Commands ****/
+
+// Debug lines, points and labels recorded by one thread. Systems running on
+// flecs worker threads each write to the buffer of their stage, so recording
+// needs no locks. Storage comes from the writing thread's frame arena.
+struct DebugDrawBuffer {
+    enum class Kind : uint8_t {
+        Strip,
+        Point,
+        Label,
+    };
+
+    struct Command {
+        uint64_t         key;     // merge order, usually the entity id
+        uint64_t         source;  // recording system, orders equal keys
+        uint32_t         seq;     // order within (key, source)
+        Kind             kind;
+        int              layer;
+        sf::Color        color;
+        uint32_t         first, count;  // range in points, or text for labels
+        TextDrawer::Opts opts;
+    };
+
+    struct Storage {
+        std::pmr::vector<Command> commands;
+        std::pmr::vector<Vec2>    points;
+        std::pmr::string          text;
+
+        Storage(std::pmr::memory_resource* resource)
+            : commands(resource), points(resource), text(resource) {}
+    };
+
+    // Bound to the writing thread's arena on first use each frame
+    std::optional<Storage> storage;
+    uint64_t               key    = 0;
+    uint64_t               source = 0;
+    uint32_t               seq    = 0;
+
+    // Tags the commands that follow. Merged output is ordered by key, then by
+    // source (pass the recording system's id, which follows registration
+    // order), then by the order commands were recorded after this call.
+    void begin(uint64_t key, uint64_t source = 0) {
+        this->key    = key;
+        this->source = source;
+        this->seq    = 0;
+    }
+
+    void line(
+        const Vec2 start,
+        const Vec2 end,
+        sf::Color  color = sf::Color::Red,
+        int        layer = 0
+    ) {
+        Vec2 pts[] = {start, end};
+        this->lineStrip(pts, color, layer);
+    }
+
+    void lineStrip(
+        std::span<const Vec2> pts,
+        sf::Color             color = sf::Color::Red,
+        int                   layer = 0
+    ) {
+        auto& points = this->bind().points;
+        this->push(Kind::Strip, layer, color, points.size(), pts.size());
+        points.insert(points.end(), pts.begin(), pts.end());
+    }
+
+    void point(const Vec2 pt, int layer = 0) {
+        auto& points = this->bind().points;
+        this->push(Kind::Point, layer, sf::Color::Red, points.size(), 1);
+        points.push_back(pt);
+    }
+
+    template <typename... Args>
+    void label(const TextDrawer::Opts& opts, Args&&... args) {
+        auto&             text = this->bind().text;
+        FrameStringStream ss(std::ios_base::out, frameArena());
+        (ss << ... << std::forward<Args>(args));
+        std::string_view str = ss.view();
+        this->push(Kind::Label, 0, {}, text.size(), str.size());
+        this->storage->commands.back().opts = opts;
+        text.append(str);
+    }
+
+   private:
+    Storage& bind() {
+        if (!this->storage) {
+            this->storage.emplace(frameArena());
+        }
+        return *this->storage;
+    }
+
+    void push(
+        Kind      kind,
+        int       layer,
+        sf::Color color,
+        size_t    first,
+        size_t    count
+    ) {
+        this->storage->commands.push_back({
+            .key    = this->key,
+            .source = this->source,
+            .seq    = this->seq++,
+            .kind   = kind,
+            .layer  = layer,
+            .color  = color,
+            .first  = uint32_t(first),
+            .count  = uint32_t(count),
+        });
+    }
+};
+
+// One buffer per flecs stage. `flush` runs on the main thread once the
+// workers are done and replays every buffer into the drawers, sorted by
+// (key, source, seq). A system handles each entity on one stage only, so that
+// triple is unique and the result doesn't depend on how entities were split
+// across threads.
+struct DebugDraw {
+    std::vector<DebugDrawBuffer> buffers;
+
+    DebugDrawBuffer& forStage(int stage) {
+        return this->buffers[stage];
+    }
+
+    void resize(int numStages) {
+        this->buffers.resize(std::max(numStages, 1));
+    }
+
+    void flush(LayeredDrawer& drawer, TextDrawer& textDrawer) {
+        struct Ref {
+            const DebugDrawBuffer*          buffer;
+            const DebugDrawBuffer::Command* cmd;
+        };
+        std::pmr::vector<Ref> refs(frameArena());
+        for (const DebugDrawBuffer& buffer : this->buffers) {
+            if (buffer.storage) {
+                for (const auto& cmd : buffer.storage->commands) {
+                    refs.push_back({&buffer, &cmd});
+                }
+            }
+        }
+        std::stable_sort(refs.begin(), refs.end(), [](auto& a, auto& b) {
+            return std::tie(a.cmd->key, a.cmd->source, a.cmd->seq) <
+                   std::tie(b.cmd->key, b.cmd->source, b.cmd->seq);
+        });
+
+        using Kind = DebugDrawBuffer::Kind;
+        for (auto [buffer, cmd] : refs) {
+            switch (cmd->kind) {
+                case Kind::Strip:
+                    drawer.lineStrip(
+                        {buffer->storage->points.data() + cmd->first,
+                         cmd->count},
+                        cmd->color, cmd->layer
+                    );
+                    break;
+                case Kind::Point:
+                    drawer.point(
+                        buffer->storage->points[cmd->first], cmd->layer
+                    );
+                    break;
+                case Kind::Label:
+                    textDrawer.draw(
+                        cmd->opts,
+                        std::string_view(buffer->storage->text)
+                            .substr(cmd->first, cmd->count)
+                    );
+                    break;
+            }
+        }
+
+        // Drop the (arena-backed) storage before the arenas are reset
+        for (DebugDrawBuffer& buffer : this->buffers) {
+            buffer.storage.reset();
+            buffer.key    = 0;
+            buffer.source = 0;
+            buffer.seq    = 0;
+        }
+    }
+};
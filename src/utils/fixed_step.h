@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+/**** Fixed Timestep ****/
+
+// Runs the simulation at a fixed tick rate, independent of the render frame
+// rate. Frame time is accumulated and consumed in whole ticks; whatever is
+// left over becomes `alpha`, the fraction of a tick the renderer should
+// interpolate by.
+//
+// At most `maxSubsteps` ticks run per frame. If a frame takes longer than
+// that, the backlog is dropped (the simulation runs slower than real time)
+// instead of making the next frame even slower.
+struct FixedStepScheduler {
+    float    tickSeconds;
+    int      maxSubsteps;
+    float    accumulator = 0;
+    float    alpha       = 0;
+    uint64_t tick        = 0;
+
+    FixedStepScheduler(float tickRate = 60, int maxSubsteps = 4)
+        : tickSeconds(1.f / tickRate), maxSubsteps(maxSubsteps) {}
+
+    // Calls `step(tickSeconds)` once per due tick, returns the number of ticks
+    // that ran.
+    template <typename Func>
+    int advance(float frameSeconds, Func&& step) {
+        this->accumulator += frameSeconds;
+
+        int steps = 0;
+        while (this->accumulator >= this->tickSeconds &&
+               steps < this->maxSubsteps) {
+            step(this->tickSeconds);
+            this->accumulator -= this->tickSeconds;
+            ++this->tick;
+            ++steps;
+        }
+
+        if (this->accumulator >= this->tickSeconds) {
+            this->accumulator = std::fmod(this->accumulator, this->tickSeconds);
+        }
+        this->alpha = this->accumulator / this->tickSeconds;
+        return steps;
+    }
+};
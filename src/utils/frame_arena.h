@@ -0,0 +1,197 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstdlib>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <vector>
+
+/**** Allocation Counters ****/
+
+// What is allocating. Set for a scope with AllocScope; allocations made
+// outside any scope count as Other.
+enum class Subsystem : uint8_t {
+    Other,
+    Physics,
+    Collision,
+    Render,
+    Text,
+    DebugDraw,
+    Stream,
+    Count,
+};
+
+const char* subsystemName(Subsystem subsystem) {
+    static const char* names[] = {"other", "physics",    "collision", "render",
+                                  "text",  "debug-draw", "stream"};
+    return names[size_t(subsystem)];
+}
+
+thread_local constinit Subsystem currentSubsystem = Subsystem::Other;
+
+struct AllocScope {
+    Subsystem previous;
+
+    AllocScope(Subsystem subsystem) : previous(currentSubsystem) {
+        currentSubsystem = subsystem;
+    }
+
+    ~AllocScope() {
+        currentSubsystem = this->previous;
+    }
+};
+
+// Counts every call to the global operator new, and flecs's own allocations
+// once countEcsAllocs() is installed, per subsystem, so we can see heap
+// traffic per frame. `lap()` returns the counts since the previous lap.
+struct AllocCounters {
+    static const size_t N = size_t(Subsystem::Count);
+
+    struct Counts {
+        uint64_t allocs = 0;
+        uint64_t bytes  = 0;
+    };
+
+    struct Snapshot {
+        uint64_t                 allocs = 0;
+        uint64_t                 bytes  = 0;
+        std::array<Counts, N> bySubsystem{};
+    };
+
+    std::array<std::atomic<uint64_t>, N> allocs{};
+    std::array<std::atomic<uint64_t>, N> bytes{};
+
+    void record(std::size_t size) {
+        size_t i = size_t(currentSubsystem);
+        allocs[i].fetch_add(1, std::memory_order_relaxed);
+        bytes[i].fetch_add(size, std::memory_order_relaxed);
+    }
+
+    Snapshot lap() {
+        Snapshot s;
+        for (size_t i = 0; i < N; ++i) {
+            s.bySubsystem[i] = {
+                .allocs = allocs[i].exchange(0, std::memory_order_relaxed),
+                .bytes  = bytes[i].exchange(0, std::memory_order_relaxed)
+            };
+            s.allocs += s.bySubsystem[i].allocs;
+            s.bytes += s.bySubsystem[i].bytes;
+        }
+        return s;
+    }
+};
+
+constinit AllocCounters allocCounters;
+
+void* operator new(std::size_t size) {
+    allocCounters.record(size);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+/**** Frame Arena ****/
+
+// Monotonic allocator for data that only lives until the end of the frame.
+// Deallocation is a no-op; everything is released at once by `reset()`.
+// The backing buffer grows to the high-water mark so that, after a few
+// frames, a frame's worth of transient data costs zero heap allocations.
+struct FrameArena : public std::pmr::memory_resource {
+    std::vector<std::byte>                             buffer;
+    std::optional<std::pmr::monotonic_buffer_resource> resource;
+    std::size_t                                        used = 0;
+
+    FrameArena(std::size_t initialBytes = 64 * 1024);
+    ~FrameArena();
+
+    void reset() {
+        if (used > buffer.size()) {
+            buffer.resize(std::bit_ceil(used));
+        }
+        used = 0;
+        resource.reset();
+        resource.emplace(buffer.data(), buffer.size());
+    }
+
+   protected:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        used += bytes + alignment - 1;
+        return resource->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void*, std::size_t, std::size_t) override {}
+
+    bool do_is_equal(const std::pmr::memory_resource& other
+    ) const noexcept override {
+        return this == &other;
+    }
+};
+
+// Every thread gets its own arena; the registry lets the main thread reset
+// all of them at the end of the frame.
+struct FrameArenaRegistry {
+    std::mutex               mutex;
+    std::vector<FrameArena*> arenas;
+};
+
+FrameArenaRegistry frameArenaRegistry;
+
+FrameArena::FrameArena(std::size_t initialBytes) : buffer(initialBytes) {
+    resource.emplace(buffer.data(), buffer.size());
+    std::lock_guard lock(frameArenaRegistry.mutex);
+    frameArenaRegistry.arenas.push_back(this);
+}
+
+FrameArena::~FrameArena() {
+    std::lock_guard lock(frameArenaRegistry.mutex);
+    std::erase(frameArenaRegistry.arenas, this);
+}
+
+// The calling thread's arena. Memory from it is valid until the next
+// `resetFrameArenas()`.
+std::pmr::memory_resource* frameArena() {
+    thread_local FrameArena arena;
+    return &arena;
+}
+
+// Resets only the calling thread's arena, for a thread that knows none of its
+// frame-arena memory is still in use (e.g. a pool worker between tasks). Don't
+// mix with `resetFrameArenas()` running on another thread.
+void resetThreadFrameArena() {
+    static_cast<FrameArena*>(frameArena())->reset();
+}
+
+// Call once per frame, when no thread holds frame-arena memory.
+void resetFrameArenas() {
+    std::lock_guard lock(frameArenaRegistry.mutex);
+    for (FrameArena* arena : frameArenaRegistry.arenas) {
+        arena->reset();
+    }
+}
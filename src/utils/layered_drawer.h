@@ -1,7 +1,10 @@
 #pragma once
 
 #include <SFML/Graphics.hpp>
+#include <memory_resource>
+#include <span>
 
+#include "frame_arena.h"
 #include "vectors.h"
 
 struct Line : public sf::Drawable {
@@ -18,13 +21,18 @@ struct Line : public sf::Drawable {
 };
 
 struct LineStrip : public sf::Drawable {
-    std::vector<sf::Vertex> vertices;
-
-    LineStrip(const std::vector<Vec2>& points) {
-        LineStrip(points, sf::Color::Red);
-    }
-
-    LineStrip(const std::vector<Vec2>& points, sf::Color color) {
+    std::pmr::vector<sf::Vertex> vertices;
+
+    LineStrip(std::span<const Vec2> points)
+        : LineStrip(points, sf::Color::Red) {}
+
+    LineStrip(
+        std::span<const Vec2>      points,
+        sf::Color                  color,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()
+    )
+        : vertices(resource) {
+        this->vertices.reserve(points.size());
         for (const auto& point : points) {
             this->vertices.push_back(sf::Vertex(point, color));
         }
@@ -57,7 +65,15 @@ struct LayeredDrawer {
     std::vector<std::vector<Drawable>> layers;
     const bool                         clearEveryFrame = false;
 
-    LayeredDrawer(int numLayers = 1) : layers(numLayers) {}
+    LayeredDrawer(int numLayers = 1, bool clearEveryFrame = false)
+        : layers(numLayers), clearEveryFrame(clearEveryFrame) {}
+
+    // Drawables that are cleared every frame can keep their buffers in the
+    // frame arena; persistent ones must stay on the heap.
+    std::pmr::memory_resource* resource() const {
+        return this->clearEveryFrame ? frameArena()
+                                     : std::pmr::get_default_resource();
+    }
 
     void draw(Drawable drawable, int layer = -1) {
         layer = layer == -1 ? this->layers.size() - 1 : layer;
@@ -70,11 +86,13 @@ struct LayeredDrawer {
     }
 
     void lineStrip(
-        const std::vector<Vec2>& points,
-        sf::Color                color = sf::Color::Red,
-        int                      layer = 0
+        std::span<const Vec2> points,
+        sf::Color             color = sf::Color::Red,
+        int                   layer = 0
     ) {
-        this->layers[layer].push_back(LineStrip{points, color});
+        this->layers[layer].push_back(
+            LineStrip{points, color, this->resource()}
+        );
     }
 
     template <std::forward_iterator It, typename Func>
@@ -83,7 +101,7 @@ struct LayeredDrawer {
             Func>
     void lineStripMap(It begin, It end, Func toWorld, int layer = -1) {
         layer = layer == -1 ? this->layers.size() - 1 : layer;
-        std::vector<Vec2> path;
+        std::pmr::vector<Vec2> path(frameArena());
         std::transform(begin, end, std::back_inserter(path), toWorld);
         this->lineStrip(path, sf::Color::Red, layer);
     }
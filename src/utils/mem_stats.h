@@ -0,0 +1,298 @@
+#pragma once
+
+#include <flecs.h>
+#include <fmt/core.h>
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "frame_arena.h"
+
+/**** ECS Allocations ****/
+
+// flecs allocates through its OS API (malloc/calloc/realloc), not operator
+// new, so its tables, columns and query caches would be invisible to
+// allocCounters. Routes them through it too; call before the first world is
+// created.
+void countEcsAllocs() {
+    ecs_os_set_api_defaults();
+    ecs_os_api_t api = ecs_os_api;
+
+    api.malloc_ = [](ecs_size_t size) {
+        allocCounters.record(size);
+        return std::malloc(size_t(size));
+    };
+    api.calloc_ = [](ecs_size_t size) {
+        allocCounters.record(size);
+        return std::calloc(1, size_t(size));
+    };
+    api.realloc_ = [](void* ptr, ecs_size_t size) {
+        allocCounters.record(size);
+        return std::realloc(ptr, size_t(size));
+    };
+    api.free_ = [](void* ptr) { std::free(ptr); };
+    ecs_os_set_api(&api);
+}
+
+/**** Memory Report ****/
+
+struct ArchetypeMemory {
+    std::string type;
+    int32_t     entities = 0;
+    int32_t     capacity = 0;
+    size_t      bytes    = 0;  // entity ids plus every component column
+};
+
+struct ComponentMemory {
+    std::string component;
+    int32_t     entities  = 0;
+    size_t      bytes     = 0;  // column storage, across all archetypes
+    size_t      heapBytes = 0;  // owned outside the column (estimate)
+};
+
+struct MemoryReport {
+    std::vector<ArchetypeMemory> archetypes;  // largest first
+    std::vector<ComponentMemory> components;  // largest first
+    size_t                       totalBytes    = 0;
+    int32_t                      totalEntities = 0;
+
+    // Short text for the in-game overlay
+    std::string overlay(size_t top = 5) const {
+        std::string out = fmt::format(
+            "ecs: {} entities, {:.1f} KiB in {} archetypes\n", totalEntities,
+            totalBytes / 1024., archetypes.size()
+        );
+        for (size_t i = 0; i < std::min(top, archetypes.size()); ++i) {
+            const ArchetypeMemory& a = archetypes[i];
+            out += fmt::format(
+                "  {:8.1f} KiB {:6} [{}]\n", a.bytes / 1024., a.entities,
+                a.type
+            );
+        }
+        for (size_t i = 0; i < std::min(top, components.size()); ++i) {
+            const ComponentMemory& c = components[i];
+            out += fmt::format(
+                "  {:8.1f} KiB (+{:.1f} heap) {}\n", c.bytes / 1024.,
+                c.heapBytes / 1024., c.component
+            );
+        }
+        return out;
+    }
+
+    // One JSON object, no trailing newline
+    void writeJson(std::FILE* out) const {
+        fmt::print(
+            out, "{{\"entities\":{},\"bytes\":{},\"archetypes\":[",
+            totalEntities, totalBytes
+        );
+        for (size_t i = 0; i < archetypes.size(); ++i) {
+            const ArchetypeMemory& a = archetypes[i];
+            fmt::print(
+                out,
+                "{}{{\"type\":\"{}\",\"entities\":{},\"capacity\":{},"
+                "\"bytes\":{}}}",
+                i ? "," : "", jsonEscape(a.type), a.entities, a.capacity,
+                a.bytes
+            );
+        }
+        fmt::print(out, "],\"components\":[");
+        for (size_t i = 0; i < components.size(); ++i) {
+            const ComponentMemory& c = components[i];
+            fmt::print(
+                out,
+                "{}{{\"component\":\"{}\",\"entities\":{},\"bytes\":{},"
+                "\"heapBytes\":{}}}",
+                i ? "," : "", jsonEscape(c.component), c.entities, c.bytes,
+                c.heapBytes
+            );
+        }
+        fmt::print(out, "]}}");
+    }
+
+    static std::string jsonEscape(std::string_view s) {
+        std::string out;
+        for (char c : s) {
+            if (c == '"' || c == '\\') {
+                out += '\\';
+            }
+            out += c;
+        }
+        return out;
+    }
+};
+
+// Heap owned by an SFML shape: its fill and outline vertex arrays
+size_t shapeHeapBytes(const sf::Shape& shape) {
+    size_t n = shape.getPointCount();
+    return ((n + 2) + (n + 1) * 2) * sizeof(sf::Vertex);
+}
+
+// Walks every table of a world and adds up what its columns hold. Keep one
+// per world; building the table query is the expensive part.
+struct MemoryStats {
+    flecs::world&  ecs;
+    flecs::query<> tables;
+
+    MemoryStats(flecs::world& ecs)
+        : ecs(ecs)
+        , tables(ecs.query_builder()
+                     .with(flecs::Any)
+                     .query_flags(
+                         EcsQueryMatchPrefab | EcsQueryMatchDisabled |
+                         EcsQueryMatchEmptyTables
+                     )
+                     .build()) {}
+
+    MemoryReport report() {
+        MemoryReport                         report;
+        std::unordered_map<ecs_id_t, size_t> componentIndex;
+        const ecs_world_t*                   world = this->ecs.c_ptr();
+
+        auto component = [&](ecs_id_t id) -> ComponentMemory& {
+            auto [it, inserted] =
+                componentIndex.try_emplace(id, report.components.size());
+            if (inserted) {
+                char* name = ecs_id_str(world, id);
+                report.components.push_back({.component = name});
+                ecs_os_free(name);
+            }
+            return report.components[it->second];
+        };
+
+        this->tables.run([&](flecs::iter& it) {
+            while (it.next()) {
+                ecs_table_t*      table    = it.c_ptr()->table;
+                const ecs_type_t* type     = ecs_table_get_type(table);
+                int32_t           count    = ecs_table_count(table);
+                int32_t           capacity = ecs_table_size(table);
+
+                char*           name = ecs_table_str(world, table);
+                ArchetypeMemory a    = {
+                    .type     = name ? name : "",
+                    .entities = count,
+                    .capacity = capacity,
+                    .bytes    = capacity * sizeof(ecs_entity_t)
+                };
+                ecs_os_free(name);
+
+                for (int32_t col = 0; col < ecs_table_column_count(table);
+                     ++col) {
+                    ecs_id_t id =
+                        type->array[ecs_table_column_to_type_index(table, col)];
+                    size_t bytes =
+                        size_t(ecs_get_type_info(world, id)->size) * capacity;
+                    a.bytes += bytes;
+
+                    ComponentMemory& c = component(id);
+                    c.entities += count;
+                    c.bytes += bytes;
+                }
+
+                report.totalBytes += a.bytes;
+                report.totalEntities += count;
+                report.archetypes.push_back(std::move(a));
+            }
+        });
+
+        this->addShapeHeap<sf::CircleShape>(component);
+        this->addShapeHeap<sf::ConvexShape>(component);
+        this->addShapeHeap<sf::RectangleShape>(component);
+
+        std::sort(
+            report.archetypes.begin(), report.archetypes.end(),
+            [](auto& a, auto& b) { return a.bytes > b.bytes; }
+        );
+        std::sort(
+            report.components.begin(), report.components.end(),
+            [](auto& a, auto& b) {
+                return a.bytes + a.heapBytes > b.bytes + b.heapBytes;
+            }
+        );
+        return report;
+    }
+
+   private:
+    template <typename Shape, typename Func>
+    void addShapeHeap(Func& component) {
+        size_t heap = 0;
+        this->ecs.each([&](const Shape& shape) {
+            heap += shapeHeapBytes(shape);
+        });
+        if (heap) {
+            component(this->ecs.id<Shape>().raw_id()).heapBytes += heap;
+        }
+    }
+};
+
+/**** Allocation Report ****/
+
+// Accumulates allocation snapshots over a run. A snapshot may cover several
+// frames; `worstFrame` then holds the worst per-frame average.
+struct AllocTotals {
+    uint64_t                frames = 0;
+    AllocCounters::Snapshot total;
+    AllocCounters::Snapshot worstFrame;
+
+    void add(const AllocCounters::Snapshot& lap, uint64_t frames = 1) {
+        if (frames == 0) {
+            return;
+        }
+        this->frames += frames;
+        this->total.allocs += lap.allocs;
+        this->total.bytes += lap.bytes;
+        for (size_t i = 0; i < AllocCounters::N; ++i) {
+            this->total.bySubsystem[i].allocs += lap.bySubsystem[i].allocs;
+            this->total.bySubsystem[i].bytes += lap.bySubsystem[i].bytes;
+        }
+        if (lap.allocs / frames > this->worstFrame.allocs) {
+            AllocCounters::Snapshot frame = lap;
+            frame.allocs /= frames;
+            frame.bytes /= frames;
+            for (auto& counts : frame.bySubsystem) {
+                counts.allocs /= frames;
+                counts.bytes /= frames;
+            }
+            this->worstFrame = frame;
+        }
+    }
+
+    void writeJson(std::FILE* out) const {
+        fmt::print(
+            out,
+            "{{\"frames\":{},\"allocs\":{},\"bytes\":{},"
+            "\"worstFrameAllocs\":{}",
+            frames, total.allocs, total.bytes, worstFrame.allocs
+        );
+        fmt::print(out, ",\"subsystems\":{{");
+        for (size_t i = 0; i < AllocCounters::N; ++i) {
+            fmt::print(
+                out, "{}\"{}\":{{\"allocs\":{},\"bytes\":{}}}", i ? "," : "",
+                subsystemName(Subsystem(i)), total.bySubsystem[i].allocs,
+                total.bySubsystem[i].bytes
+            );
+        }
+        fmt::print(out, "}}}}");
+    }
+};
+
+// Per-subsystem line for the overlay
+std::string allocOverlay(const AllocCounters::Snapshot& frame) {
+    std::string out = fmt::format(
+        "heap allocs/frame: {} ({} B)\n", frame.allocs, frame.bytes
+    );
+    for (size_t i = 0; i < AllocCounters::N; ++i) {
+        if (frame.bySubsystem[i].allocs) {
+            out += fmt::format(
+                "  {:10} {:6} ({} B)\n", subsystemName(Subsystem(i)),
+                frame.bySubsystem[i].allocs, frame.bySubsystem[i].bytes
+            );
+        }
+    }
+    return out;
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "vectors.h"
+
+/**** Disk Grid ****/
+
+// Uniform grid over a rectangle for disks of any radius. A disk is stored in
+// every cell its bounding box touches, so an overlap test only looks at the
+// cells under the candidate, however large either disk is.
+struct DiskGrid {
+    struct Disk {
+        Vec2  pos;
+        float radius;
+    };
+
+    Vec2                               min;
+    float                              cellSize;
+    int                                cols, rows;
+    std::vector<Disk>                  disks;
+    std::vector<std::vector<uint32_t>> cells;  // indices into disks
+
+    DiskGrid(Vec2 min, Vec2 max, float cellSize)
+        : min(min)
+        , cellSize(cellSize)
+        , cols(std::max(1, int(std::ceil((max.x - min.x) / cellSize))))
+        , rows(std::max(1, int(std::ceil((max.y - min.y) / cellSize))))
+        , cells(size_t(cols) * rows) {}
+
+    bool fits(Vec2 pos, float radius) const {
+        bool fits = true;
+        this->forCells(pos, radius, [&](size_t cell) {
+            for (uint32_t i : this->cells[cell]) {
+                const Disk& d    = this->disks[i];
+                Vec2        diff = d.pos - pos;
+                float       r    = d.radius + radius;
+                if (diff.x * diff.x + diff.y * diff.y < r * r) {
+                    fits = false;
+                    return false;
+                }
+            }
+            return true;
+        });
+        return fits;
+    }
+
+    void insert(Vec2 pos, float radius) {
+        uint32_t index = this->disks.size();
+        this->disks.push_back({pos, radius});
+        this->forCells(pos, radius, [&](size_t cell) {
+            this->cells[cell].push_back(index);
+            return true;
+        });
+    }
+
+   private:
+    // Calls `f` with every cell under the disk's bounding box until it
+    // returns false
+    template <typename Func>
+    void forCells(Vec2 pos, float radius, Func&& f) const {
+        auto cell = [&](float v, float min, int count) {
+            return std::clamp(int((v - min) / this->cellSize), 0, count - 1);
+        };
+        int x0 = cell(pos.x - radius, this->min.x, this->cols);
+        int x1 = cell(pos.x + radius, this->min.x, this->cols);
+        int y0 = cell(pos.y - radius, this->min.y, this->rows);
+        int y1 = cell(pos.y + radius, this->min.y, this->rows);
+        for (int y = y0; y <= y1; ++y) {
+            for (int x = x0; x <= x1; ++x) {
+                if (!f(size_t(y) * this->cols + x)) {
+                    return;
+                }
+            }
+        }
+    }
+};
+
+/**** Poisson Disk Placement ****/
+
+// Places one non-overlapping disk per radius inside [min, max] by dart
+// throwing, largest first, and returns the centers in the order of `radii`.
+// Throws if a disk can't be placed in `attempts` tries, so the result is
+// always complete. The layout depends only on `gen` and the radii.
+std::vector<Vec2> poissonDiskPlacement(
+    std::mt19937&             gen,
+    const std::vector<float>& radii,
+    Vec2                      min,
+    Vec2                      max,
+    int                       attempts = 1000
+) {
+    std::vector<Vec2> centers(radii.size());
+    if (radii.empty()) {
+        return centers;
+    }
+
+    std::vector<uint32_t> order(radii.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return radii[a] > radii[b];
+    });
+
+    // Cells about the size of a typical disk keep both the cells a disk
+    // covers and the disks per cell small
+    float    cellSize = std::max(2 * radii[order[order.size() / 2]], 1.f);
+    DiskGrid grid(min, max, cellSize);
+
+    for (uint32_t i : order) {
+        float r      = radii[i];
+        bool  placed = false;
+        if (max.x - min.x >= 2 * r && max.y - min.y >= 2 * r) {
+            std::uniform_real_distribution<float> x(min.x + r, max.x - r);
+            std::uniform_real_distribution<float> y(min.y + r, max.y - r);
+            for (int a = 0; a < attempts && !placed; ++a) {
+                Vec2 pos(x(gen), y(gen));
+                if (grid.fits(pos, r)) {
+                    grid.insert(pos, r);
+                    centers[i] = pos;
+                    placed     = true;
+                }
+            }
+        }
+        if (!placed) {
+            throw std::runtime_error(fmt::format(
+                "Could not place disk {} of {} (radius {}) without overlap",
+                i + 1, radii.size(), r
+            ));
+        }
+    }
+    return centers;
+}
@@ -2,7 +2,12 @@
 
 #include <fmt/core.h>
 
+#include <memory_resource>
+#include <sstream>
+#include <string_view>
+
 #include "SFML/Graphics.hpp"
+#include "frame_arena.h"
 #include "vectors.h"
 
 /**** Text ******/
@@ -18,10 +23,17 @@ sf::Font loadFont(const std::string& path) {
     return font;
 }
 
+// String stream whose buffer lives in the frame arena
+using FrameStringStream = std::basic_ostringstream<
+    char,
+    std::char_traits<char>,
+    std::pmr::polymorphic_allocator<char>>;
+
 struct TextDrawer {
     sf::Font              font;
     std::vector<sf::Text> texts;
 
+    TextDrawer() = default;
     TextDrawer(const std::string& fontPath) : font(loadFont(fontPath)) {}
 
     struct Opts {
@@ -33,10 +45,10 @@ struct TextDrawer {
     };
 
     static sf::Text
-    makeText(const Opts& opts, const std::string& str, const sf::Font& font) {
+    makeText(const Opts& opts, std::string_view str, const sf::Font& font) {
         sf::Text text;
         text.setFont(opts.font.value_or(font));
-        text.setString(str);
+        text.setString(sf::String::fromUtf8(str.begin(), str.end()));
         text.setCharacterSize(opts.size.value_or(12));
         text.setFillColor(opts.color.value_or(sf::Color::White));
         if (opts.centered) {
@@ -56,14 +68,14 @@ struct TextDrawer {
 
     template <typename... Args>
     void draw(const Opts& opts, Args&&... args) {
-        std::stringstream ss;
+        FrameStringStream ss(std::ios_base::out, frameArena());
         (ss << ... << std::forward<Args>(args));
-        const std::string str =
-            ss.str();  // force usage of non-template base overload
+        const std::string_view str =
+            ss.view();  // force usage of non-template base overload
         this->draw(opts, str);
     }
 
-    void draw(const Opts& opts, const std::string& str) {
+    void draw(const Opts& opts, std::string_view str) {
         this->texts.push_back(makeText(opts, str, this->font));
     }
 
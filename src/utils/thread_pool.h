@@ -0,0 +1,132 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**** Work Stealing Pool ****/
+
+// Each worker owns a deque. Workers pop from the back of their own deque and,
+// when it is empty, steal from the front of the others'. Tasks submitted from
+// a worker go to that worker's deque; tasks submitted from outside are dealt
+// round-robin.
+struct WorkStealingPool {
+    using Task = std::function<void()>;
+
+    struct Worker {
+        std::mutex       mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::jthread>            threads;
+
+    std::mutex              mutex;  // guards the sleep/wake and wait state
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::atomic<int>        queued     = 0;
+    int                     pending    = 0;  // submitted but not yet finished
+    bool                    stopping   = false;
+    std::atomic<size_t>     nextWorker = 0;
+
+    static inline thread_local const WorkStealingPool* workerPool  = nullptr;
+    static inline thread_local int                     workerIndex = -1;
+
+    WorkStealingPool(int numThreads = std::thread::hardware_concurrency()) {
+        numThreads = std::max(numThreads, 1);
+        for (int i = 0; i < numThreads; ++i) {
+            this->workers.push_back(std::make_unique<Worker>());
+        }
+        for (int i = 0; i < numThreads; ++i) {
+            this->threads.emplace_back([this, i] { this->run(i); });
+        }
+    }
+
+    ~WorkStealingPool() {
+        {
+            std::lock_guard lock(this->mutex);
+            this->stopping = true;
+        }
+        this->wake.notify_all();
+        this->threads.clear();  // joins
+    }
+
+    int size() const {
+        return this->workers.size();
+    }
+
+    void submit(Task task) {
+        int index = workerPool == this
+                        ? workerIndex
+                        : this->nextWorker++ % this->workers.size();
+        {
+            std::lock_guard lock(this->mutex);
+            ++this->pending;
+            ++this->queued;
+        }
+        {
+            std::lock_guard lock(this->workers[index]->mutex);
+            this->workers[index]->tasks.push_back(std::move(task));
+        }
+        this->wake.notify_one();
+    }
+
+    // Blocks until every submitted task has finished
+    void wait() {
+        std::unique_lock lock(this->mutex);
+        this->idle.wait(lock, [this] { return this->pending == 0; });
+    }
+
+   private:
+    bool pop(int self, Task& task) {
+        int n = this->workers.size();
+        for (int k = 0; k < n; ++k) {
+            Worker& w = *this->workers[(self + k) % n];
+            std::lock_guard lock(w.mutex);
+            if (w.tasks.empty()) {
+                continue;
+            }
+            if (k == 0) {
+                task = std::move(w.tasks.back());
+                w.tasks.pop_back();
+            } else {
+                task = std::move(w.tasks.front());
+                w.tasks.pop_front();
+            }
+            --this->queued;
+            return true;
+        }
+        return false;
+    }
+
+    void run(int self) {
+        workerPool  = this;
+        workerIndex = self;
+        Task task;
+        while (true) {
+            if (this->pop(self, task)) {
+                task();
+                task = nullptr;
+                std::lock_guard lock(this->mutex);
+                if (--this->pending == 0) {
+                    this->idle.notify_all();
+                }
+                continue;
+            }
+
+            std::unique_lock lock(this->mutex);
+            this->wake.wait(lock, [this] {
+                return this->stopping || this->queued > 0;
+            });
+            if (this->stopping && this->queued == 0) {
+                return;
+            }
+        }
+    }
+};
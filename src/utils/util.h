@@ -3,15 +3,18 @@
 #include <flecs.h>
 
 #include <iostream>
+#include <random>
 #include <sstream>
 
+#include "debug_draw.h"
+#include "fixed_step.h"
+#include "frame_arena.h"
 #include "layered_drawer.h"
+#include "mem_stats.h"
 #include "newtype.h"
 #include "text.h"
 #include "vectors.h"
 
-// Note: Utility globals defined at bottom of the file
-
 /**** Printing ****/
 
 template <typename T>
@@ -58,30 +61,50 @@ operator|(std::variant<Ts...> const& v, match<Fs...> const& match) {
     return std::visit(match, v);
 }
 
-/*********************/
-/**** Bad Globals ****/
-/*********************/
+/**** World Context ****/
+
+// State that used to be process-wide globals. Every flecs::world owns one,
+// reachable through the world ctx, so several worlds can live in (and be
+// ticked from different threads of) the same process.
+struct WorldCtx {
+    std::mt19937  gen;
+    LayeredDrawer drawer{2, /*clearEveryFrame=*/true};
+    TextDrawer    textDrawer;
+    // What systems record instead of touching the drawers directly; flushed
+    // into them on the main thread (see DebugDraw)
+    DebugDraw     debugDraw;
+
+    // An empty font path skips loading the font (headless worlds)
+    WorldCtx(uint32_t seed, const std::string& fontPath = "")
+        : gen(seed)
+        , textDrawer(fontPath.empty() ? TextDrawer() : TextDrawer(fontPath)) {}
+};
 
-TextDrawer    textDrawer("./open-sans/OpenSans-Bold.ttf");
-LayeredDrawer drawer(2);
-const int     SIM_DEBUG_LAYER = 0;
+WorldCtx& worldCtx(const flecs::world& ecs) {
+    return *static_cast<WorldCtx*>(ecs.get_ctx());
+}
 
-std::random_device rd;         // Seed
-std::mt19937       gen(rd());  // Mersenne Twister engine
+const int SIM_DEBUG_LAYER = 0;
 
 /**** Random ****/
 
-int randomInt(int min, int max) {
+int randomInt(std::mt19937& gen, int min, int max) {
     std::uniform_int_distribution<int> dist(min, max);
     return dist(gen);
 }
 
-float randomFloat(float min, float max) {
+float randomFloat(std::mt19937& gen, float min, float max) {
     std::uniform_real_distribution<float> dist(min, max);
     return dist(gen);
 }
 
 // Function to generate a random Vec2 within the given range
-Vec2 randomVec2(float minX, float maxX, float minY, float maxY) {
-    return {randomFloat(minX, maxX), randomFloat(minY, maxY)};
+Vec2 randomVec2(
+    std::mt19937& gen,
+    float         minX,
+    float         maxX,
+    float         minY,
+    float         maxY
+) {
+    return {randomFloat(gen, minX, maxX), randomFloat(gen, minY, maxY)};
 }
\ No newline at end of file
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "sim.h"
+#include "utils/thread_pool.h"
+
+/**** Multi-World Host ****/
+
+struct TickLatency {
+    uint64_t ticks   = 0;
+    double   lastMs  = 0;
+    double   totalMs = 0;
+    double   maxMs   = 0;
+
+    void record(double ms) {
+        ++this->ticks;
+        this->lastMs = ms;
+        this->totalMs += ms;
+        this->maxMs = std::max(this->maxMs, ms);
+    }
+
+    double meanMs() const {
+        return this->ticks ? this->totalMs / this->ticks : 0;
+    }
+};
+
+// Owns many independent headless simulations and ticks them in parallel on a
+// work-stealing pool. Worlds share nothing but the pool and advance at their
+// own pace between calls to `run`.
+struct WorldHost {
+    std::vector<std::unique_ptr<Sim>> sims;
+    std::vector<TickLatency>          latency;
+    WorkStealingPool                  pool;  // declared last: joins first
+
+    // World `i` is seeded with `base.seed + i` and streams, if enabled, to
+    // `base.streamPath.i`
+    WorldHost(int numWorlds, const SimConfig& base, int numThreads)
+        : latency(numWorlds), pool(numThreads) {
+        for (int i = 0; i < numWorlds; ++i) {
+            SimConfig config = base;
+            config.seed      = base.seed + i;
+            config.fontPath  = "";
+            if (!base.streamPath.empty()) {
+                config.streamPath = fmt::format("{}.{}", base.streamPath, i);
+            }
+            this->sims.push_back(std::make_unique<Sim>(config));
+            this->sims.back()->spawnScenario();
+        }
+    }
+
+    // Runs `ticks` fixed ticks of every world. Each world is a chain of tasks
+    // that resubmits itself from its worker, so a slow world never holds up
+    // the others and idle workers steal whatever is queued. The only barrier
+    // is at the end.
+    void run(int ticks) {
+        if (ticks <= 0) {
+            return;
+        }
+        for (size_t i = 0; i < this->sims.size(); ++i) {
+            this->pool.submit([this, i, ticks] { this->tickWorld(i, ticks); });
+        }
+        this->pool.wait();
+    }
+
+    void report() const {
+        for (size_t i = 0; i < this->sims.size(); ++i) {
+            const TickLatency& l = this->latency[i];
+            fmt::println(
+                "world {:3}: {:6} ticks, {:8.3f} ms mean, {:8.3f} ms max, "
+                "{:6} entities",
+                i, l.ticks, l.meanMs(), l.maxMs,
+                this->sims[i]->ecs.count<Position>()
+            );
+        }
+    }
+
+   private:
+    void tickWorld(size_t i, int remaining) {
+        Sim& sim   = *this->sims[i];
+        auto start = now();
+        sim.advance(sim.scheduler.tickSeconds);
+        std::chrono::duration<double, std::milli> elapsed = now() - start;
+        this->latency[i].record(elapsed.count());
+
+        // A task keeps no frame-arena memory past its end, so the worker can
+        // reset its own arena without waiting for the others
+        resetThreadFrameArena();
+
+        if (remaining > 1) {
+            this->pool.submit([this, i, remaining] {
+                this->tickWorld(i, remaining - 1);
+            });
+        }
+    }
+};